@@ -1,6 +1,9 @@
 #pragma once
 
 #include "bench.h"
+#include "options.h"
+#include "replay.h"
+#include "soak.h"
 #include "ycsb.h"
 #include "sqlHelpers.h"
 
@@ -44,40 +47,71 @@ void prepareYcsb(SQLHDBC connection) {
    }
 }
 
-// Do transactions with statements
-// https://docs.microsoft.com/en-us/sql/relational-databases/native-client-odbc-how-to/execute-queries/use-a-statement-odbc
-void doSmallTx(SQLHDBC connection) {
+auto prepareSmallTxStatements(SQLHDBC connection) {
    auto columnStatements = std::vector<StatementHandle>();
    for (size_t i = 1; i < ycsb_field_count + 1; ++i) {
       columnStatements.push_back(allocateStatementHandle(connection));
       auto statement = std::string("SELECT v") + std::to_string(i) + " FROM #Ycsb WHERE ycsb_key=?;";
       prepareStatement(columnStatements.back().get(), statement.c_str());
    }
+   return columnStatements;
+}
 
-   auto rand = Random32();
-   const auto lookupKeys = generateZipfLookupKeys(ycsb_tx_count);
-
-   std::cout << "benchmarking " << lookupKeys.size() << " small transactions" << '\n';
+void doSmallTxLookup(std::vector<StatementHandle> &columnStatements, YcsbKey lookupKey, size_t which) {
    auto result = std::array<wchar_t, ycsb_field_length>();
 
-   auto timeTaken = bench([&] {
-      for (auto lookupKey: lookupKeys) {
-         auto which = rand.next() % ycsb_field_count;
+   bindKeyParam(columnStatements[which].get(), lookupKey);
+   executeStatement(columnStatements[which].get());
+   checkColumns(columnStatements[which].get());
+
+   db.lookup(lookupKey, which, result.begin());
+   fetchAndCheckReturnValue(columnStatements[which].get(), result.data());
+
+   SQLCloseCursor(columnStatements[which].get());
+}
+
+// Do transactions with statements
+// https://docs.microsoft.com/en-us/sql/relational-databases/native-client-odbc-how-to/execute-queries/use-a-statement-odbc
+void doSmallTx(SQLHDBC connection, double theta = 1.0, KeyDistribution distribution = KeyDistribution::Zipf) {
+   auto columnStatements = prepareSmallTxStatements(connection);
 
-         bindKeyParam(columnStatements[which].get(), lookupKey);
-         executeStatement(columnStatements[which].get());
-         checkColumns(columnStatements[which].get());
+   auto rand = Random32();
+   const auto lookupKeys = generateZipfLookupKeys(ycsb_tx_count, theta, distribution);
 
-         db.lookup(lookupKey, which, result.begin());
-         fetchAndCheckReturnValue(columnStatements[which].get(), result.data());
+   std::cout << "benchmarking " << lookupKeys.size() << " small transactions ("
+             << keyDistributionName(distribution) << ", theta " << theta << ")" << '\n';
 
-         SQLCloseCursor(columnStatements[which].get());
+   auto timeTaken = bench([&] {
+      for (auto lookupKey: lookupKeys) {
+         doSmallTxLookup(columnStatements, lookupKey, rand.next() % ycsb_field_count);
       }
    });
 
    std::cout << " " << lookupKeys.size() / timeTaken << " msg/s\n";
 }
 
+void doSmallTxZipfSweep(SQLHDBC connection, KeyDistribution distribution) {
+   for (auto theta : zipfSweepThetas) {
+      doSmallTx(connection, theta, distribution);
+   }
+}
+
+void soakSmallTx(SQLHDBC connection, std::chrono::seconds duration, TimeSeriesWriter &writer,
+                 double theta, KeyDistribution distribution) {
+   auto columnStatements = prepareSmallTxStatements(connection);
+
+   // Keys are drawn online, a precomputed buffer would repeat its key sequence periodically over a long run
+   auto rand = Random32();
+   auto keyRand = Random64();
+   const auto keyGenerator = ZipfGenerator(ycsb_tuple_count, theta, distribution);
+
+   std::cout << "soaking small transactions for " << duration.count() << "s" << '\n';
+   soak(duration, writer, [&] {
+      const auto lookupKey = static_cast<YcsbKey>(keyGenerator.next(keyRand));
+      doSmallTxLookup(columnStatements, lookupKey, rand.next() % ycsb_field_count);
+   });
+}
+
 void doLargeResultSet(SQLHDBC connection) {
    const auto results = size_t(1e6);
    const auto recordSize = 1024; // ~ 1GB
@@ -148,8 +182,7 @@ void doLargeResultSet(SQLHDBC connection) {
    selectFromTempTable.reset();
 }
 
-void doInternalSmallTx(SQLHDBC connection) {
-   const auto iterations = size_t(1e6);
+auto prepareInternalSmallTx(SQLHDBC connection, size_t iterations) {
    auto statementHandle = allocateStatementHandle(connection);
    const auto statement = std::string()
                           + "DECLARE @i int = 0;\n"
@@ -159,27 +192,68 @@ void doInternalSmallTx(SQLHDBC connection) {
                           + "    SET @i = @i + 1\n"
                           + "END";
    prepareStatement(statementHandle.get(), statement.c_str());
+   return statementHandle;
+}
+
+void doInternalSmallTxBatch(SQLHSTMT statementHandle, size_t iterations) {
+   executeStatement(statementHandle);
+
+   auto buffer = std::array<char, 64>();
+   bindColumn<char>(statementHandle, 1, buffer);
+
+   for (size_t j = 0; j < iterations; ++j) {
+      fetchBoundColumns(statementHandle);
+      if (buffer[0] != '1') {
+         throw std::runtime_error("unexpected return value from SQL statement");
+      }
+   }
+
+   SQLCloseCursor(statementHandle);
+}
+
+void doInternalSmallTx(SQLHDBC connection) {
+   const auto iterations = size_t(1e6);
+   auto statementHandle = prepareInternalSmallTx(connection, iterations);
 
    std::cout << "benchmarking " << iterations << " very small internal transactions" << '\n';
 
    const auto averaging = size_t(1e2);
    auto timeTaken = bench([&] {
       for (size_t i = 0; i < averaging; ++i) {
-         executeStatement(statementHandle.get());
+         doInternalSmallTxBatch(statementHandle.get(), iterations);
+      }
+   });
 
-         auto buffer = std::array<char, 64>();
-         bindColumn<char>(statementHandle.get(), 1, buffer);
+   std::cout << " " << iterations / (timeTaken / averaging) << " msg/s\n";
+}
 
-         for (size_t j = 0; j < iterations; ++j) {
-            fetchBoundColumns(statementHandle.get());
-            if (buffer[0] != '1') {
-               throw std::runtime_error("unexpected return value from SQL statement");
-            }
-         }
+void soakInternalSmallTx(SQLHDBC connection, std::chrono::seconds duration, TimeSeriesWriter &writer) {
+   // Small batches, so that a single operation stays well below the sampling interval
+   const auto iterations = size_t(1e3);
+   auto statementHandle = prepareInternalSmallTx(connection, iterations);
 
-         SQLCloseCursor(statementHandle.get());
-      }
+   std::cout << "soaking batches of " << iterations << " very small internal transactions for "
+             << duration.count() << "s" << '\n';
+   soak(duration, writer, [&] {
+      doInternalSmallTxBatch(statementHandle.get(), iterations);
    });
+}
 
-   std::cout << " " << iterations / (timeTaken / averaging) << " msg/s\n";
+void runSmallTx(SQLHDBC connection, const BenchmarkOptions &options) {
+   if (options.zipfSweep) {
+      doSmallTxZipfSweep(connection, options.keyDistribution);
+   } else {
+      doSmallTx(connection, options.theta, options.keyDistribution);
+   }
+}
+
+void runSoak(SQLHDBC connection, const BenchmarkOptions &options) {
+   auto writer = TimeSeriesWriter(options.soakOutput);
+   if (options.soakWorkload == "smalltx") {
+      soakSmallTx(connection, options.soakDuration, writer, options.theta, options.keyDistribution);
+   } else if (options.soakWorkload == "internal") {
+      soakInternalSmallTx(connection, options.soakDuration, writer);
+   } else {
+      throw std::runtime_error("unknown soak workload: " + options.soakWorkload);
+   }
 }
@@ -30,11 +30,20 @@ int main(int argc, char* argv[]) {
          "Trusted_Connection=yes;");
 
    auto connectionStrings = std::vector<std::string>();
+   auto options = BenchmarkOptions();
 
-   if (argc == 2) {
+   if (argc >= 2) {
       connectionStrings.emplace_back(argv[1]);
+      try {
+         options = parseOptions(argc, argv, 2);
+      }
+      catch (const std::exception &e) {
+         std::cout << e.what() << '\n'
+                   << "usage: odbcBenchmark <connection string> [options]\n" << optionsUsage;
+         return -1;
+      }
    } else {
-      std::cout << "usage: odbcBenchmark <connection string>\n"
+      std::cout << "usage: odbcBenchmark <connection string> [options]\n" << optionsUsage
                 << "now testing all possible connections\n\n";
       for (const auto &protocol : protocols) {
          connectionStrings.emplace_back(connectionPrefix + protocol += connectionSuffix);
@@ -49,10 +58,19 @@ int main(int argc, char* argv[]) {
          connectAndPrintConnectionString(connectionString, connection.get());
          checkAndPrintConnection(connection.get());
 
-         prepareYcsb(connection.get());
-         doSmallTx(connection.get());
-         doLargeResultSet(connection.get());
-         doInternalSmallTx(connection.get());
+         if (!options.replayTrace.empty()) {
+            runReplay(environment.get(), [&](SQLHDBC replayConnection) {
+               connectWithConnectionString(connectionString, replayConnection);
+            }, options);
+         } else if (options.soakWorkload.empty()) {
+            prepareYcsb(connection.get());
+            runSmallTx(connection.get(), options);
+            doLargeResultSet(connection.get());
+            doInternalSmallTx(connection.get());
+         } else {
+            prepareYcsb(connection.get());
+            runSoak(connection.get(), options);
+         }
          SQLDisconnect(connection.get());
       }
       catch (const std::runtime_error &e) {
@@ -7,8 +7,16 @@ using namespace std;
   * ODBC benchmark with simpler connection string interface
   */
 int main(int argc, char* argv[]) {
-   if (argc < 4) {
-      std::cout << "usage: odbcBenchmarkSQLConnect <host> <user> <password>";
+   auto options = BenchmarkOptions();
+   try {
+      if (argc < 4) {
+         throw std::runtime_error("missing connection arguments");
+      }
+      options = parseOptions(argc, argv, 4);
+   }
+   catch (const std::exception &e) {
+      std::cout << e.what() << '\n'
+                << "usage: odbcBenchmarkSQLConnect <host> <user> <password> [options]\n" << optionsUsage;
       return -1;
    }
    auto serverName = argv[1];
@@ -22,10 +30,19 @@ int main(int argc, char* argv[]) {
       connect(serverName, userName, password, connection.get());
       checkAndPrintConnection(connection.get());
 
-      prepareYcsb(connection.get());
-      doSmallTx(connection.get());
-      doLargeResultSet(connection.get());
-      doInternalSmallTx(connection.get());
+      if (!options.replayTrace.empty()) {
+         runReplay(environment.get(), [&](SQLHDBC replayConnection) {
+            connect(serverName, userName, password, replayConnection);
+         }, options);
+      } else if (options.soakWorkload.empty()) {
+         prepareYcsb(connection.get());
+         runSmallTx(connection.get(), options);
+         doLargeResultSet(connection.get());
+         doInternalSmallTx(connection.get());
+      } else {
+         prepareYcsb(connection.get());
+         runSoak(connection.get(), options);
+      }
       SQLDisconnect(connection.get());
    }
    catch (const std::runtime_error &e) {
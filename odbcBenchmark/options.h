@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "util/ZipfGenerator.h"
+
+/// Optional command line arguments shared by all benchmark executables
+struct BenchmarkOptions {
+   std::string soakWorkload; // empty: run the fixed count benchmarks
+   std::chrono::seconds soakDuration{0};
+   std::string soakOutput;
+   double theta = 1.0;
+   KeyDistribution keyDistribution = KeyDistribution::Zipf;
+   bool zipfSweep = false; // run the lookup benchmark for every theta in zipfSweepThetas
+   std::string replayTrace; // replay this trace file instead of running the benchmarks
+   double replaySpeed = 0.0; // 0: as fast as possible, otherwise scales the original timing
+};
+
+static constexpr double zipfSweepThetas[] = {0.0, 0.25, 0.5, 0.75, 0.99, 1.25, 1.5};
+
+static constexpr auto optionsUsage =
+      "  --soak <smalltx|internal> <seconds> <output.csv|output.json>\n"
+      "      run one workload for the given duration and stream a per second time series\n"
+      "  --theta <skew>\n"
+      "      Zipf skew of the lookup keys, 0 is uniform (default: 1.0)\n"
+      "  --distribution <zipf|scrambled|latest>\n"
+      "      hot keys are the first keys, hashed over all keys, or the last inserted keys (default: zipf)\n"
+      "  --zipf-sweep\n"
+      "      run the lookup benchmark for thetas from 0 to 1.5\n"
+      "  --replay <trace file>\n"
+      "      replay a captured statement trace, one connection per trace connection id\n"
+      "  --speed <factor>\n"
+      "      replay at the original timing scaled by factor, 0 is as fast as possible (default: 0)\n";
+
+const char* keyDistributionName(KeyDistribution distribution) {
+   switch (distribution) {
+      case KeyDistribution::ScrambledZipf:
+         return "scrambled";
+      case KeyDistribution::Latest:
+         return "latest";
+      case KeyDistribution::Zipf:
+      default:
+         return "zipf";
+   }
+}
+
+BenchmarkOptions parseOptions(int argc, char* argv[], int first) {
+   auto options = BenchmarkOptions();
+   auto keyOptionGiven = false;
+   auto speedGiven = false;
+   for (auto i = first; i < argc; ++i) {
+      const auto arg = std::string(argv[i]);
+      if (arg == "--soak") {
+         if (i + 3 >= argc) {
+            throw std::runtime_error("--soak expects a workload, a duration and an output file");
+         }
+         options.soakWorkload = argv[++i];
+         if (options.soakWorkload != "smalltx" && options.soakWorkload != "internal") {
+            throw std::runtime_error("unknown soak workload: " + options.soakWorkload);
+         }
+         options.soakDuration = std::chrono::seconds(std::stoll(argv[++i]));
+         if (options.soakDuration.count() <= 0) {
+            throw std::runtime_error("--soak duration must be positive");
+         }
+         options.soakOutput = argv[++i];
+      } else if (arg == "--theta") {
+         if (i + 1 >= argc) {
+            throw std::runtime_error("--theta expects a skew factor");
+         }
+         options.theta = std::stod(argv[++i]);
+         keyOptionGiven = true;
+         if (!std::isfinite(options.theta) || options.theta < 0.0) {
+            throw std::runtime_error("--theta must be a finite, non-negative number");
+         }
+      } else if (arg == "--distribution") {
+         if (i + 1 >= argc) {
+            throw std::runtime_error("--distribution expects zipf, scrambled or latest");
+         }
+         const auto distribution = std::string(argv[++i]);
+         keyOptionGiven = true;
+         if (distribution == "zipf") {
+            options.keyDistribution = KeyDistribution::Zipf;
+         } else if (distribution == "scrambled") {
+            options.keyDistribution = KeyDistribution::ScrambledZipf;
+         } else if (distribution == "latest") {
+            options.keyDistribution = KeyDistribution::Latest;
+         } else {
+            throw std::runtime_error("unknown key distribution: " + distribution);
+         }
+      } else if (arg == "--zipf-sweep") {
+         options.zipfSweep = true;
+      } else if (arg == "--replay") {
+         if (i + 1 >= argc) {
+            throw std::runtime_error("--replay expects a trace file");
+         }
+         options.replayTrace = argv[++i];
+      } else if (arg == "--speed") {
+         if (i + 1 >= argc) {
+            throw std::runtime_error("--speed expects a factor");
+         }
+         options.replaySpeed = std::stod(argv[++i]);
+         speedGiven = true;
+         if (!std::isfinite(options.replaySpeed) || options.replaySpeed < 0.0) {
+            throw std::runtime_error("--speed must be a finite, non-negative number");
+         }
+      } else {
+         throw std::runtime_error("unknown argument: " + arg);
+      }
+   }
+
+   if (!options.replayTrace.empty() && (!options.soakWorkload.empty() || options.zipfSweep || keyOptionGiven)) {
+      throw std::runtime_error("--replay cannot be combined with --soak, --zipf-sweep, --theta or --distribution");
+   }
+   if (speedGiven && options.replayTrace.empty()) {
+      throw std::runtime_error("--speed needs --replay");
+   }
+   if (!options.soakWorkload.empty() && options.zipfSweep) {
+      throw std::runtime_error("--zipf-sweep cannot be combined with --soak");
+   }
+   if (options.soakWorkload == "internal" && keyOptionGiven) {
+      throw std::runtime_error("the internal soak workload does not use --theta or --distribution");
+   }
+   return options;
+}
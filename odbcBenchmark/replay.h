@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "bench.h"
+#include "options.h"
+#include "sqlHelpers.h"
+#include "util/LatencyHistogram.h"
+
+/**
+  * Trace files are tab separated text, one entry per line:
+  *   # comment
+  *   !<statement id>  <sql>                                        defines a statement id
+  *   <timestamp>  <connection id>  <sql | @statement id>  [<parameter>...]
+  * Timestamps are in microseconds, parameters are bound as characters to the '?' markers of the statement,
+  * a parameter that is exactly \N is NULL and \t, \n, \\ can be used to escape tabs, newlines and backslashes.
+  * A statement must always be used with the same number of parameters.
+  * Every trace connection id is replayed on its own ODBC connection, in trace order.
+  */
+struct TraceEvent {
+   uint64_t timestamp;
+   size_t statement;
+   std::vector<std::optional<std::string>> parameters;
+};
+
+struct Trace {
+   std::vector<std::string> statements; // sql text, indexed by TraceEvent::statement
+   std::vector<std::string> statementNames;
+   std::vector<std::optional<std::vector<size_t>>> parameterSizes; // longest value per parameter, set on first use
+   std::map<std::string, std::vector<TraceEvent>> connections;
+   uint64_t firstTimestamp = UINT64_MAX;
+   uint64_t lastTimestamp = 0;
+   size_t eventCount = 0;
+};
+
+/// Splits a line at tabs and resolves escapes, a field that is exactly \N is NULL
+std::vector<std::optional<std::string>> splitTraceLine(const std::string &line) {
+   auto fields = std::vector<std::optional<std::string>>();
+   for (size_t begin = 0; begin <= line.size();) {
+      auto end = line.find('\t', begin);
+      if (end == std::string::npos) {
+         end = line.size();
+      }
+      const auto raw = std::string_view(line).substr(begin, end - begin);
+      begin = end + 1;
+
+      if (raw == "\\N") {
+         fields.emplace_back(std::nullopt);
+         continue;
+      }
+      auto &field = fields.emplace_back(std::string());
+      for (size_t i = 0; i < raw.size(); ++i) {
+         if (raw[i] == '\\' && i + 1 < raw.size()) {
+            switch (raw[++i]) {
+               case 't':
+                  *field += '\t';
+                  break;
+               case 'n':
+                  *field += '\n';
+                  break;
+               default:
+                  *field += raw[i];
+            }
+         } else {
+            *field += raw[i];
+         }
+      }
+   }
+   return fields;
+}
+
+/// Inverse of the escaping in splitTraceLine, so that values can be printed into tab separated output
+std::string escapeTraceField(const std::string &value) {
+   auto res = std::string();
+   for (auto c : value) {
+      switch (c) {
+         case '\t':
+            res += "\\t";
+            break;
+         case '\n':
+            res += "\\n";
+            break;
+         case '\r':
+            res += ' ';
+            break;
+         case '\\':
+            res += "\\\\";
+            break;
+         default:
+            res += c;
+      }
+   }
+   return res;
+}
+
+Trace loadTrace(const std::string &fileName) {
+   auto in = std::ifstream(fileName);
+   if (!in) {
+      throw std::runtime_error("could not open " + fileName);
+   }
+
+   auto trace = Trace();
+   auto statementIds = std::unordered_map<std::string, size_t>(); // "@id" or sql text -> statement
+   const auto addStatement = [&](const std::string &key, const std::string &sql, const std::string &name) {
+      const auto[it, inserted] = statementIds.emplace(key, trace.statements.size());
+      if (inserted) {
+         trace.statements.push_back(sql);
+         trace.statementNames.push_back(name);
+         trace.parameterSizes.emplace_back();
+      }
+      return it->second;
+   };
+
+   auto line = std::string();
+   for (size_t lineNumber = 1; std::getline(in, line); ++lineNumber) {
+      if (!line.empty() && line.back() == '\r') {
+         line.pop_back();
+      }
+      if (line.empty() || line[0] == '#') {
+         continue;
+      }
+      const auto error = [&](const std::string &what) {
+         return std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": " + what);
+      };
+
+      const auto fields = splitTraceLine(line);
+      const auto field = [&](size_t i) {
+         if (!fields[i]) {
+            throw error("only parameters can be NULL");
+         }
+         return *fields[i];
+      };
+
+      if (line[0] == '!') {
+         if (fields.size() != 2) {
+            throw error("statement definitions need an id and the sql text");
+         }
+         const auto id = "@" + field(0).substr(1);
+         if (statementIds.count(id) != 0) {
+            throw error("duplicate statement id " + id);
+         }
+         addStatement(id, field(1), id);
+         continue;
+      }
+
+      if (fields.size() < 3) {
+         throw error("events need a timestamp, a connection id and a statement");
+      }
+      auto event = TraceEvent();
+      const auto timestamp = field(0);
+      if (timestamp.empty() || timestamp.find_first_not_of("0123456789") != std::string::npos) {
+         throw error("invalid timestamp " + timestamp);
+      }
+      try {
+         event.timestamp = std::stoull(timestamp);
+      }
+      catch (const std::out_of_range &) {
+         throw error("timestamp out of range " + timestamp);
+      }
+      const auto statement = field(2);
+      if (statement[0] == '@') {
+         const auto it = statementIds.find(statement);
+         if (it == statementIds.end()) {
+            throw error("undefined statement id " + statement);
+         }
+         event.statement = it->second;
+      } else {
+         event.statement = addStatement(statement, statement, escapeTraceField(statement).substr(0, 60));
+      }
+      event.parameters.assign(fields.begin() + 3, fields.end());
+
+      // Every execution binds the same number and size of parameters, so the driver never has to re-prepare
+      auto &sizes = trace.parameterSizes[event.statement];
+      if (!sizes) {
+         sizes.emplace(event.parameters.size(), 1);
+      } else if (sizes->size() != event.parameters.size()) {
+         throw error(std::to_string(event.parameters.size()) + " parameters for " +
+                     trace.statementNames[event.statement] + ", which was first used with " +
+                     std::to_string(sizes->size()));
+      }
+      for (size_t i = 0; i < event.parameters.size(); ++i) {
+         if (event.parameters[i]) {
+            (*sizes)[i] = std::max((*sizes)[i], event.parameters[i]->size());
+         }
+      }
+
+      trace.firstTimestamp = std::min(trace.firstTimestamp, event.timestamp);
+      trace.lastTimestamp = std::max(trace.lastTimestamp, event.timestamp);
+      trace.connections[field(1)].push_back(std::move(event));
+      ++trace.eventCount;
+   }
+   return trace;
+}
+
+/// A statement prepared on one connection, with the results of its executions there
+struct ReplayStatement {
+   StatementHandle handle;
+   LatencyHistogram latencies;
+   uint64_t errors;
+};
+
+/// Only the statements a connection uses, ad-hoc traces can contain many distinct statements
+using ReplayStatements = std::unordered_map<size_t, ReplayStatement>;
+
+/// Prepares every statement the events use, so that preparing does not show up in the replay
+ReplayStatements prepareTraceStatements(SQLHDBC connection, const Trace &trace,
+                                        const std::vector<TraceEvent> &events) {
+   auto statements = ReplayStatements();
+   for (const auto &event : events) {
+      if (statements.count(event.statement) == 0) {
+         auto handle = allocateStatementHandle(connection);
+         disableDeferredPrepare(handle.get());
+         prepareStatement(handle.get(), trace.statements[event.statement].c_str());
+         statements.emplace(event.statement, ReplayStatement{std::move(handle), LatencyHistogram(), 0});
+      }
+   }
+   return statements;
+}
+
+void replayConnection(ReplayStatements &statements, const Trace &trace, const std::vector<TraceEvent> &events,
+                      double speed, std::chrono::steady_clock::time_point start) {
+   auto indicators = std::vector<SQLLEN>();
+   for (const auto &event : events) {
+      if (speed > 0) {
+         const auto offset = std::chrono::duration<double>((event.timestamp - trace.firstTimestamp) / 1e6 / speed);
+         std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+      }
+
+      auto &statement = statements.at(event.statement);
+      const auto statementHandle = statement.handle.get();
+      const auto &parameterSizes = *trace.parameterSizes[event.statement];
+      const auto opStart = std::chrono::steady_clock::now();
+      try {
+         SQLFreeStmt(statementHandle, SQL_RESET_PARAMS);
+         indicators.resize(event.parameters.size());
+         for (size_t i = 0; i < event.parameters.size(); ++i) {
+            const auto &parameter = event.parameters[i];
+            bindStringParam(statementHandle, SQLUSMALLINT(i + 1), parameter ? &*parameter : nullptr,
+                            SQLULEN(parameterSizes[i]), indicators[i]);
+         }
+         executeStatement(statementHandle);
+         drainResultSets(statementHandle);
+      }
+      catch (const std::runtime_error &) {
+         // Captured traffic may fail legitimately (e.g. duplicate keys), keep replaying
+         SQLFreeStmt(statementHandle, SQL_CLOSE);
+         ++statement.errors;
+         continue;
+      }
+      const auto opEnd = std::chrono::steady_clock::now();
+      statement.latencies.record(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(opEnd - opStart).count()));
+   }
+}
+
+auto connectDbConnection(SQLHENV environment, const std::function<void(SQLHDBC)> &connect) {
+   auto connection = allocateDbConnection(environment);
+   connect(connection.get());
+   return ConnectedDbConnection(connection.release(), &disconnectAndFreeDbConnection);
+}
+
+/// Replays the trace with one thread and connection per trace connection id
+/// speed 0 replays as fast as possible, otherwise the original timing is scaled by 1 / speed
+void replayTrace(SQLHENV environment, const std::function<void(SQLHDBC)> &connect, const Trace &trace,
+                 double speed) {
+   // The sleep offsets are steady_clock durations, keep them far from overflowing
+   if (speed > 0 && (trace.lastTimestamp - trace.firstTimestamp) / 1e6 / speed > 1e9) {
+      throw std::runtime_error("trace spans too long to be replayed at this speed");
+   }
+
+   // Declared before the statements, so that those are freed before disconnecting
+   auto connections = std::vector<ConnectedDbConnection>();
+   auto statements = std::vector<ReplayStatements>();
+   for (const auto &[connectionId, events] : trace.connections) {
+      connections.push_back(connectDbConnection(environment, connect));
+      statements.push_back(prepareTraceStatements(connections.back().get(), trace, events));
+   }
+
+   std::cout << "replaying " << trace.eventCount << " statements on " << connections.size() << " connections";
+   if (speed > 0) {
+      std::cout << " at " << speed << "x original speed\n";
+   } else {
+      std::cout << " as fast as possible\n";
+   }
+
+   auto failures = std::vector<std::string>(connections.size());
+   auto threads = std::vector<std::thread>();
+   const auto start = std::chrono::steady_clock::now();
+   auto timeTaken = bench([&] {
+      auto events = trace.connections.begin();
+      for (size_t i = 0; i < connections.size(); ++i, ++events) {
+         threads.emplace_back([&, i, events] {
+            try {
+               replayConnection(statements[i], trace, events->second, speed, start);
+            }
+            catch (const std::runtime_error &e) {
+               failures[i] = "connection " + events->first + ": " + e.what();
+            }
+         });
+      }
+      for (auto &thread : threads) {
+         thread.join();
+      }
+   });
+
+   for (const auto &failure : failures) {
+      if (!failure.empty()) {
+         std::cout << failure << '\n';
+      }
+   }
+
+   auto totalExecuted = uint64_t(0);
+   auto totalErrors = uint64_t(0);
+   std::cout << "statement\tcount\terrors\tmean_us\tp50_us\tp99_us\tmax_us\n";
+   for (size_t s = 0; s < trace.statements.size(); ++s) {
+      auto latencies = LatencyHistogram();
+      auto errors = uint64_t(0);
+      for (const auto &connectionStatements : statements) {
+         const auto it = connectionStatements.find(s);
+         if (it != connectionStatements.end()) {
+            latencies.merge(it->second.latencies);
+            errors += it->second.errors;
+         }
+      }
+      totalExecuted += latencies.count();
+      totalErrors += errors;
+      std::cout << trace.statementNames[s] << '\t' << latencies.count() << '\t' << errors << '\t'
+                << latencies.mean() / 1e3 << '\t' << latencies.percentile(0.5) / 1e3 << '\t'
+                << latencies.percentile(0.99) / 1e3 << '\t' << latencies.max() / 1e3 << '\n';
+   }
+
+   // Failed statements are not counted, they can fail much faster than they would execute
+   std::cout << " " << totalExecuted / timeTaken << " statements/s, " << totalErrors << " failed\n";
+}
+
+void runReplay(SQLHENV environment, const std::function<void(SQLHDBC)> &connect, const BenchmarkOptions &options) {
+   const auto trace = loadTrace(options.replayTrace);
+   replayTrace(environment, connect, trace, options.replaySpeed);
+}
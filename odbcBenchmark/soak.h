@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "sqlHelpers.h"
+#include "util/LatencyHistogram.h"
+#include "util/processStats.h"
+
+/// One interval of a soak run, latencies in microseconds
+struct SoakSample {
+   double elapsed; // seconds since the start of the soak run
+   uint64_t operations;
+   double throughput;
+   double p50Latency;
+   double p99Latency;
+   double maxLatency;
+   size_t residentSetSize;
+   size_t osHandles;
+   long statementHandles;
+};
+
+/// Streams soak samples to a CSV file, or to JSON lines if the file name ends in ".json"
+/// Every sample is flushed right away, so the time series survives an aborted run
+class TimeSeriesWriter {
+   std::ofstream out;
+   bool json;
+
+public:
+   explicit TimeSeriesWriter(const std::string &fileName)
+         : out(fileName), json(fileName.size() >= 5 && fileName.compare(fileName.size() - 5, 5, ".json") == 0) {
+      if (!out) {
+         throw std::runtime_error("could not open " + fileName);
+      }
+      // Default precision would drop the fraction of elapsed_s after ~28h and switch large rates to 1e+06 notation
+      out << std::fixed << std::setprecision(3);
+      if (!json) {
+         out << "elapsed_s,ops,ops_per_s,p50_us,p99_us,max_us,rss_bytes,os_handles,statement_handles\n";
+      }
+   }
+
+   void write(const SoakSample &s) {
+      if (json) {
+         out << "{\"elapsed_s\":" << s.elapsed
+             << ",\"ops\":" << s.operations
+             << ",\"ops_per_s\":" << s.throughput
+             << ",\"p50_us\":" << s.p50Latency
+             << ",\"p99_us\":" << s.p99Latency
+             << ",\"max_us\":" << s.maxLatency
+             << ",\"rss_bytes\":" << s.residentSetSize
+             << ",\"os_handles\":" << s.osHandles
+             << ",\"statement_handles\":" << s.statementHandles << "}\n";
+      } else {
+         out << s.elapsed << ',' << s.operations << ',' << s.throughput << ','
+             << s.p50Latency << ',' << s.p99Latency << ',' << s.maxLatency << ','
+             << s.residentSetSize << ',' << s.osHandles << ',' << s.statementHandles << '\n';
+      }
+      out.flush();
+   }
+};
+
+/// Runs fun repeatedly for the given duration and writes one sample per interval
+/// Latencies go into a fixed size histogram that is reset after each sample, so memory stays constant
+template<typename T>
+void soak(std::chrono::seconds duration, TimeSeriesWriter &writer, T &&fun,
+          std::chrono::milliseconds interval = std::chrono::seconds(1)) {
+   using clock = std::chrono::steady_clock;
+   const auto toMicroseconds = [](uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+
+   auto histogram = LatencyHistogram();
+   auto totalOperations = uint64_t(0);
+   const auto start = clock::now();
+   const auto end = start + duration;
+   auto intervalStart = start;
+
+   const auto emitSample = [&](clock::time_point now) {
+      const auto intervalLength = std::chrono::duration<double>(now - intervalStart).count();
+      writer.write(SoakSample{
+            std::chrono::duration<double>(now - start).count(),
+            histogram.count(),
+            histogram.count() / intervalLength,
+            toMicroseconds(histogram.percentile(0.5)),
+            toMicroseconds(histogram.percentile(0.99)),
+            toMicroseconds(histogram.max()),
+            currentResidentSetSize(),
+            currentHandleCount(),
+            liveStatementHandles.load()
+      });
+      totalOperations += histogram.count();
+      histogram.reset();
+      intervalStart = now;
+   };
+
+   for (auto opStart = start; opStart < end; opStart = clock::now()) {
+      fun();
+      const auto done = clock::now();
+      histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - opStart).count()));
+      if (done - intervalStart >= interval) {
+         emitSample(done);
+      }
+   }
+   if (histogram.count() > 0) {
+      emitSample(clock::now());
+   }
+
+   const auto timeTaken = std::chrono::duration<double>(clock::now() - start).count();
+   std::cout << " " << totalOperations << " ops, " << totalOperations / timeTaken << " ops/s\n";
+}
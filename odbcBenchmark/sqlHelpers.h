@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -35,6 +36,14 @@ auto allocateODBC3Environment() {
 
 void freeDbConnection(SQLHDBC connection) { SQLFreeHandle(SQL_HANDLE_DBC, connection); }
 
+void disconnectAndFreeDbConnection(SQLHDBC connection) {
+   SQLDisconnect(connection);
+   freeDbConnection(connection);
+}
+
+/// Connection that is disconnected before it is freed, since SQLFreeHandle fails on a connected handle
+using ConnectedDbConnection = std::unique_ptr<std::remove_pointer_t<SQLHDBC>, decltype(&disconnectAndFreeDbConnection)>;
+
 auto allocateDbConnection(SQLHENV environment) {
    auto connection = SQLHDBC();
    if (SQLAllocHandle(SQL_HANDLE_DBC, environment, &connection) != SQL_SUCCESS) {
@@ -43,7 +52,13 @@ auto allocateDbConnection(SQLHENV environment) {
    return std::unique_ptr<std::remove_pointer_t<SQLHDBC>, decltype(&freeDbConnection)>(connection, &freeDbConnection);
 }
 
-void freeStatementHandle(SQLHSTMT statementHandle) { SQLFreeHandle(SQL_HANDLE_STMT, statementHandle); }
+/// Number of statement handles currently allocated through allocateStatementHandle, used to spot handle leaks
+static auto liveStatementHandles = std::atomic<long>(0);
+
+void freeStatementHandle(SQLHSTMT statementHandle) {
+   SQLFreeHandle(SQL_HANDLE_STMT, statementHandle);
+   --liveStatementHandles;
+}
 
 using StatementHandle = std::unique_ptr<std::remove_pointer_t<SQLHSTMT>, decltype(&freeStatementHandle)>;
 
@@ -52,9 +67,22 @@ auto allocateStatementHandle(SQLHDBC connection) {
    if (SQLAllocHandle(SQL_HANDLE_STMT, connection, &statementHandle) != SQL_SUCCESS) {
       throw std::runtime_error("SQLAllocHandle failed");
    }
+   ++liveStatementHandles;
    return StatementHandle(statementHandle, &freeStatementHandle);
 }
 
+// SQL Server specific statement attribute, see msodbcsql.h
+#ifndef SQL_SOPT_SS_DEFER_PREPARE
+#define SQL_SOPT_SS_DEFER_PREPARE 1236
+#define SQL_DP_OFF 0L
+#endif
+
+/// The SQL Server driver defers SQLPrepare to the first SQLExecute by default, this prepares right away instead
+/// Drivers that do not know the attribute return an error, which is ignored
+void disableDeferredPrepare(SQLHSTMT statementHandle) {
+   SQLSetStmtAttr(statementHandle, SQL_SOPT_SS_DEFER_PREPARE, reinterpret_cast<SQLPOINTER>(SQL_DP_OFF), SQL_IS_INTEGER);
+}
+
 void prepareStatement(SQLHSTMT statementHandle, const char* statement) {
    const auto statementLength = SQLINTEGER(strlen(statement));
    if (SQLPrepare(statementHandle, (SQLCHAR*) statement, statementLength) == SQL_ERROR) {
@@ -83,7 +111,7 @@ void handleError(SQLRETURN res, SQLSMALLINT handleType, SQLHANDLE handle) {
    throw std::runtime_error("SQLDriverConnect failed, did you enter an invalid connection string?\n" + error);
 }
 
-void connectAndPrintConnectionString(const std::string &connectionString, SQLHDBC connection) {
+auto connectWithConnectionString(const std::string &connectionString, SQLHDBC connection) {
    auto rawConnectionString = (SQLCHAR*) (connectionString.c_str());
    const auto connectionStringLength = SQLSMALLINT(connectionString.length());
    auto out = std::array<SQLCHAR, 512>();
@@ -98,7 +126,11 @@ void connectAndPrintConnectionString(const std::string &connectionString, SQLHDB
          handleError(res, SQL_HANDLE_DBC, connection);
    }
 
-   std::cout << "connected to " << std::string(out.begin(), out.end()) << '\n';
+   return std::string(out.begin(), out.end());
+}
+
+void connectAndPrintConnectionString(const std::string &connectionString, SQLHDBC connection) {
+   std::cout << "connected to " << connectWithConnectionString(connectionString, connection) << '\n';
 }
 
 void connect(const std::string &serverName, const std::string &userName, const std::string &password,
@@ -153,6 +185,21 @@ void bindKeyParam(const SQLHSTMT &statementHandle, uint32_t &key) {
                     SQL_INTEGER, 10, 0, &key, 1, nullptr);
 }
 
+/// Binds a character parameter, the value and indicator must stay alive until the statement is executed
+/// Keep columnSize the same for every execution, otherwise the driver may re-prepare the statement
+void bindStringParam(const SQLHSTMT &statementHandle, SQLUSMALLINT parameterNumber, const std::string* value,
+                     SQLULEN columnSize, SQLLEN &indicator) {
+   indicator = value ? SQLLEN(value->size()) : SQL_NULL_DATA;
+   if (columnSize > 8000) {
+      columnSize = 0; // varchar(max), SQL Server rejects larger varchar(n)
+   }
+   const auto buffer = value ? const_cast<char*>(value->data()) : nullptr;
+   if (SQLBindParameter(statementHandle, parameterNumber, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, columnSize, 0,
+                        buffer, indicator == SQL_NULL_DATA ? 0 : indicator, &indicator) == SQL_ERROR) {
+      throw std::runtime_error("SQLBindParameter failed");
+   }
+}
+
 template<typename bufferType, size_t bufferSize>
 void
 bindColumn(const SQLHSTMT &statementHandle, SQLUSMALLINT columnNumber, std::array<bufferType, bufferSize> &buffer) {
@@ -167,6 +214,28 @@ void fetchBoundColumns(const SQLHSTMT &statementHandle) {
    }
 }
 
+/// Fetches and discards all rows of all result sets, then closes the cursor
+void drainResultSets(SQLHSTMT statementHandle) {
+   auto res = SQLRETURN();
+   do {
+      auto cols = SQLSMALLINT();
+      if (SQLNumResultCols(statementHandle, &cols) == SQL_ERROR) {
+         throw std::runtime_error("SQLNumResultCols failed");
+      }
+      if (cols > 0) {
+         while ((res = SQLFetch(statementHandle)) == SQL_SUCCESS || res == SQL_SUCCESS_WITH_INFO);
+         if (res == SQL_ERROR) {
+            throw std::runtime_error("SQLFetch failed");
+         }
+      }
+      res = SQLMoreResults(statementHandle);
+   } while (res == SQL_SUCCESS || res == SQL_SUCCESS_WITH_INFO);
+   SQLFreeStmt(statementHandle, SQL_CLOSE);
+   if (res == SQL_ERROR) {
+      throw std::runtime_error("SQLMoreResults failed");
+   }
+}
+
 void checkAndPrintConnection(SQLHDBC connection) {
    auto connectionTest = "select net_transport from sys.dm_exec_connections where session_id = @@SPID;";
    const auto length = SQLINTEGER(::strlen(connectionTest));
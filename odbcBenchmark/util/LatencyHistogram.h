@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// Log-linear latency histogram with constant memory, similar in spirit to HdrHistogram
+/// Every power of two is split into 16 linear sub-buckets, so the relative error is at most 1/16
+class LatencyHistogram {
+    static constexpr unsigned subBucketBits = 4;
+    static constexpr uint64_t subBucketCount = uint64_t(1) << subBucketBits;
+    static constexpr size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+    std::array<uint64_t, bucketCount> buckets{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t maximum = 0;
+
+    static unsigned log2(uint64_t value) {
+        auto res = 0u;
+        while (value >>= 1) {
+            ++res;
+        }
+        return res;
+    }
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < subBucketCount) {
+            return static_cast<size_t>(value);
+        }
+        const auto shift = log2(value) - subBucketBits;
+        return static_cast<size_t>((shift + 1) * subBucketCount + ((value >> shift) & (subBucketCount - 1)));
+    }
+
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < subBucketCount) {
+            return index;
+        }
+        const auto shift = index / subBucketCount - 1;
+        const auto lower = (subBucketCount + index % subBucketCount) << shift;
+        return lower + (uint64_t(1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t value) {
+        ++buckets[bucketIndex(value)];
+        ++total;
+        sum += value;
+        if (value > maximum) {
+            maximum = value;
+        }
+    }
+
+    uint64_t count() const { return total; }
+
+    uint64_t max() const { return maximum; }
+
+    double mean() const { return total == 0 ? 0.0 : static_cast<double>(sum) / total; }
+
+    /// Value below which the given fraction (0..1) of the recorded values lie
+    uint64_t percentile(double fraction) const {
+        const auto rank = static_cast<uint64_t>(fraction * total);
+        auto seen = uint64_t(0);
+        for (size_t i = 0; i < bucketCount; ++i) {
+            seen += buckets[i];
+            if (seen > rank) {
+                const auto upper = bucketUpperBound(i);
+                return upper < maximum ? upper : maximum;
+            }
+        }
+        return maximum;
+    }
+
+    void merge(const LatencyHistogram &other) {
+        for (size_t i = 0; i < bucketCount; ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        if (other.maximum > maximum) {
+            maximum = other.maximum;
+        }
+    }
+
+    void reset() {
+        buckets.fill(0);
+        total = 0;
+        sum = 0;
+        maximum = 0;
+    }
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+/// https://en.wikipedia.org/wiki/Xorshift#xorshift*
+class Random64 {
+    uint64_t state;
+public:
+    explicit Random64(uint64_t seed = 88172645463325252ull) : state(seed) {}
+
+    uint64_t next() {
+        state ^= (state >> 12);
+        state ^= (state << 25);
+        state ^= (state >> 27);
+        return state * 2685821657736338717ull;
+    }
+
+    /// Uniformly distributed in [0, 1)
+    double nextDouble() {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+enum class KeyDistribution {
+    Zipf,          // key 0 is the hottest
+    ScrambledZipf, // hot keys are hashed over the whole key space
+    Latest         // the most recently inserted (largest) keys are the hottest
+};
+
+/// Zipf distributed keys in [0, keyCount) with constant memory and setup time
+/// Rejection-inversion sampling, see: W. Hoermann, G. Derflinger:
+/// "Rejection-inversion to generate variates from monotone discrete distributions", 1996
+/// Same approach as Apache Commons RNG's RejectionInversionZipfSampler, theta = 0 degenerates to uniform
+class ZipfGenerator {
+    uint64_t keyCount;
+    double theta;
+    KeyDistribution distribution;
+    double hIntegralX1;
+    double hIntegralKeyCount;
+    double s;
+
+    /// log(1 + x) / x, numerically stable around 0
+    static double helper1(double x) {
+        if (std::abs(x) > 1e-8) {
+            return std::log1p(x) / x;
+        }
+        return 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+
+    /// (exp(x) - 1) / x, numerically stable around 0
+    static double helper2(double x) {
+        if (std::abs(x) > 1e-8) {
+            return std::expm1(x) / x;
+        }
+        return 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+    }
+
+    double h(double x) const {
+        return std::exp(-theta * std::log(x));
+    }
+
+    double hIntegral(double x) const {
+        const auto logX = std::log(x);
+        return helper2((1.0 - theta) * logX) * logX;
+    }
+
+    double hIntegralInverse(double x) const {
+        auto t = x * (1.0 - theta);
+        if (t < -1.0) {
+            t = -1.0; // limit value for rounding errors
+        }
+        return std::exp(helper1(t) * x);
+    }
+
+    /// 64 bit FNV-1a over the bytes of the rank, as used by YCSB's ScrambledZipfianGenerator
+    static uint64_t fnvHash(uint64_t value) {
+        auto hash = 0xCBF29CE484222325ull;
+        for (auto i = 0; i < 8; ++i) {
+            hash ^= value & 0xFF;
+            hash *= 1099511628211ull;
+            value >>= 8;
+        }
+        return hash;
+    }
+
+    /// Zipf rank in [1, keyCount]
+    template<typename Random>
+    uint64_t nextRank(Random &rand) const {
+        if (theta == 0.0) {
+            const auto rank = 1 + static_cast<uint64_t>(rand.nextDouble() * keyCount);
+            return rank > keyCount ? keyCount : rank;
+        }
+        while (true) {
+            const auto u = hIntegralKeyCount + rand.nextDouble() * (hIntegralX1 - hIntegralKeyCount);
+            const auto x = hIntegralInverse(u);
+            auto k = static_cast<uint64_t>(x + 0.5);
+            if (k < 1) {
+                k = 1;
+            } else if (k > keyCount) {
+                k = keyCount;
+            }
+            if (k - x <= s || u >= hIntegral(k + 0.5) - h(static_cast<double>(k))) {
+                return k;
+            }
+        }
+    }
+
+public:
+    ZipfGenerator(uint64_t keyCount, double theta, KeyDistribution distribution = KeyDistribution::Zipf)
+            : keyCount(keyCount), theta(theta), distribution(distribution) {
+        if (keyCount == 0) {
+            throw std::runtime_error("Zipf distribution needs at least one key");
+        }
+        // NaN or infinity would fail every acceptance test in nextRank and loop forever
+        if (!std::isfinite(theta) || theta < 0.0) {
+            throw std::runtime_error("Zipf theta must be finite and not negative");
+        }
+        hIntegralX1 = hIntegral(1.5) - 1.0;
+        hIntegralKeyCount = hIntegral(static_cast<double>(keyCount) + 0.5);
+        s = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+    }
+
+    template<typename Random>
+    uint64_t next(Random &rand) const {
+        const auto rank = nextRank(rand);
+        switch (distribution) {
+            case KeyDistribution::ScrambledZipf:
+                return fnvHash(rank) % keyCount;
+            case KeyDistribution::Latest:
+                return keyCount - rank;
+            case KeyDistribution::Zipf:
+            default:
+                return rank - 1;
+        }
+    }
+};
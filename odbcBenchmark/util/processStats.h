@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <dirent.h>
+#include <fstream>
+#include <unistd.h>
+#endif
+
+/// Resident set size of this process in bytes, 0 if not available on this platform
+size_t currentResidentSetSize() {
+#ifdef _WIN32
+    auto counters = PROCESS_MEMORY_COUNTERS();
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#else
+    // https://man7.org/linux/man-pages/man5/proc.5.html: size resident shared text lib data dt, in pages
+    auto statm = std::ifstream("/proc/self/statm");
+    size_t size = 0;
+    size_t resident = 0;
+    if (!(statm >> size >> resident)) {
+        return 0;
+    }
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/// Number of OS handles (file descriptors on POSIX) held by this process, 0 if not available on this platform
+size_t currentHandleCount() {
+#ifdef _WIN32
+    auto count = DWORD();
+    if (!GetProcessHandleCount(GetCurrentProcess(), &count)) {
+        return 0;
+    }
+    return count;
+#else
+    auto dir = opendir("/proc/self/fd");
+    if (dir == nullptr) {
+        return 0;
+    }
+    size_t count = 0;
+    while (auto entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            ++count;
+        }
+    }
+    closedir(dir);
+    return count - 1; // the descriptor of the directory we just iterated
+#endif
+}
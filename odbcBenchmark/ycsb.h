@@ -2,11 +2,18 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <limits>
 #include <random>
+#include <stdexcept>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 #include "util/Random32.h"
+#include "util/Random64.h"
+#include "util/ZipfGenerator.h"
 #include "util/doNotOptimize.h"
 
 /// YCSB Benchmark workload, based on Alexander van Renen's version
@@ -68,22 +75,37 @@ auto generateLookupKeys(size_t count, size_t maxValue) {
     return res;
 }
 
-auto generateZipfLookupKeys(size_t count, double factor = 1.0) {
-    using distribution = std::discrete_distribution<size_t>;
-    std::mt19937 generator(88172645463325252ull);
-    auto zipfdist = [&] {
-        std::vector<double> buffer(ycsb_tuple_count + 1);
-        for (unsigned rank = 1; rank <= ycsb_tuple_count; ++rank) {
-            buffer[rank] = std::pow(rank, -factor);
+/// Generates the keys in parallel, in fixed size chunks with their own seed, so the result does not depend on the
+/// number of cores. Memory besides the result is constant, keyCount is only limited by the 32 bit YcsbKey
+auto generateZipfLookupKeys(size_t count, double theta = 1.0, KeyDistribution distribution = KeyDistribution::Zipf,
+                            uint64_t keyCount = ycsb_tuple_count) {
+    if (keyCount > uint64_t(std::numeric_limits<YcsbKey>::max()) + 1) {
+        throw std::runtime_error("keyCount exceeds the range of YcsbKey");
+    }
+    const auto generator = ZipfGenerator(keyCount, theta, distribution);
+    auto res = std::vector<YcsbKey>(count);
+
+    const auto chunkSize = size_t(1) << 16;
+    const auto chunkCount = (count + chunkSize - 1) / chunkSize;
+    auto nextChunk = std::atomic<size_t>(0);
+    const auto worker = [&] {
+        for (auto chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+            auto rand = Random64(88172645463325252ull + chunk * 0x9E3779B97F4A7C15ull);
+            const auto begin = res.begin() + chunk * chunkSize;
+            const auto end = res.begin() + std::min(count, (chunk + 1) * chunkSize);
+            std::generate(begin, end, [&] { return static_cast<YcsbKey>(generator.next(rand)); });
         }
+    };
 
-        return distribution(buffer.begin() + 1, buffer.end());
-    }();
-    auto rand = [&] { return zipfdist(generator); };
-
-    auto res = std::vector<YcsbKey>();
-    res.reserve(count);
-    std::generate_n(std::back_inserter(res), count, [&] { return static_cast<unsigned int>(rand()); });
+    const auto threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), chunkCount);
+    auto threads = std::vector<std::thread>();
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
     return res;
 }
 